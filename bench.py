@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+
+# ======================================================================
+#
+#     Copyright (C) 2004 and onward Robert Muth <robert at muth dot org>
+#
+#     This program is free software: you can redistribute it and/or modify
+#     it under the terms of the GNU General Public License as published by
+#     the Free Software Foundation, version 3 of the License.
+#
+#     This program is distributed in the hope that it will be useful,
+#     but WITHOUT ANY WARRANTY; without even the implied warranty of
+#     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#     GNU General Public License for more details.
+#
+# ======================================================================
+
+"""
+Benchmarks the apetag modes on a synthetic corpus (see mkcorpus.py).
+
+Every mode is run repeatedly on a fresh copy of every corpus file, each
+run through benchrun (see benchrun.C). For each mode and file the latency
+percentiles, CPU time, throughput, peak RSS and the number of read and
+write system calls (as counted by /proc/<pid>/io, other system calls are
+not included) are reported.
+
+With a baseline the results are compared against it and the benchmark
+fails if the peak RSS or the number of read and write system calls
+regressed by more than the threshold. Latencies depend on the machine the
+baseline was taken on, they are only compared with -T.
+"""
+
+USAGE = """
+bench.py - benchmark apetag
+usage:
+    bench.py [options]
+options:
+    -a apetag      the binary to benchmark (default ./apetag)
+    -r benchrun    the benchrun binary (default ./benchrun)
+    -c directory   where to put the corpus (default _bench)
+    -n runs        runs per mode and file (default 15)
+    -b baseline    compare against this baseline file
+    -t threshold   allowed relative regression (default 0.25)
+    -s             save the results as the new baseline instead
+    -T             also fail on median latency regressions, only useful
+                   with a baseline taken on the same machine
+"""
+
+# python imports
+import collections
+import getopt
+import json
+import os
+import shutil
+import subprocess
+import sys
+
+# local imports
+import mkcorpus
+
+# ======================================================================
+# mode, apetag options; the file to work on is passed with -i, {out} is
+# replaced by an output file name
+MODES = [
+    ("read", ["-m", "read"]),
+    ("update", ["-m", "update", "-p", "Title=bench update"]),
+    ("overwrite", ["-m", "overwrite", "-p", "Title=bench overwrite"]),
+    ("erase", ["-m", "erase"]),
+    ("extract", ["-m", "read", "-f", mkcorpus.BINARY_KEY + "={out}"]),
+]
+
+# regressions smaller than these are noise
+SLACK_MS = 1.0
+SLACK_RSS_KB = 1024
+SLACK_RW_SYSCALLS = 2
+
+# wall and cpu time in seconds, peak RSS in KB, read and write system calls
+RUN = collections.namedtuple("RUN", "wall cpu max_rss rw_syscalls")
+
+# ======================================================================
+def percentile(values, fraction):
+    values = sorted(values)
+    index = int(round(fraction * (len(values) - 1)))
+    return values[index]
+
+
+def run_once(benchrun, argv):
+    """returns a RUN for one execution of argv"""
+    fields = subprocess.check_output([benchrun] + argv).split()
+    if fields[0] != b"0":
+        raise RuntimeError("failed: " + " ".join(argv))
+    rw_syscalls = None
+    if fields[5] != b"-":
+        rw_syscalls = int(fields[5]) + int(fields[6])
+    return RUN(int(fields[1]) / 1e6, (int(fields[2]) + int(fields[3])) / 1e6,
+               int(fields[4]), rw_syscalls)
+
+
+def bench_mode(benchrun, apetag, options, source, work, runs):
+    """returns a RUN for each of runs executions"""
+    out = work + ".out"
+    result = []
+    # the first run only warms the cache
+    for i in range(runs + 1):
+        shutil.copyfile(source, work)
+        if os.path.exists(out):
+            os.unlink(out)
+        argv = ([apetag, "-i", work] +
+                [o.replace("{out}", out) for o in options])
+        run = run_once(benchrun, argv)
+        if i:
+            result.append(run)
+    for name in (work, out):
+        if os.path.exists(name):
+            os.unlink(name)
+    return result
+
+
+def summarize(runs, tag_size):
+    latencies = [r.wall for r in runs]
+    mean = sum(latencies) / len(latencies)
+    return {
+        "p50_ms": 1000 * percentile(latencies, 0.5),
+        "p90_ms": 1000 * percentile(latencies, 0.9),
+        "p99_ms": 1000 * percentile(latencies, 0.99),
+        "cpu_ms": 1000 * sum(r.cpu for r in runs) / len(runs),
+        "files_per_s": 1 / mean,
+        "tag_mb_per_s": tag_size / mean / (1 << 20),
+        "max_rss_kb": max(r.max_rss for r in runs),
+        "rw_syscalls": runs[0].rw_syscalls,
+    }
+
+
+def run_benchmarks(benchrun, apetag, directory, runs):
+    results = {}
+    corpus = mkcorpus.make_corpus(os.path.join(directory, "corpus"))
+    work = os.path.join(directory, "work.ape")
+    for name, path, case in corpus:
+        binary_size = case[3]
+        tag_size = os.path.getsize(path) - mkcorpus.AUDIO_SIZE
+        for mode, options in MODES:
+            if mode == "extract" and not binary_size:
+                continue
+            results[mode + "/" + name] = summarize(
+                bench_mode(benchrun, apetag, options, path, work, runs),
+                tag_size)
+    return results
+
+# ======================================================================
+def report(results):
+    print("%-22s %7s %7s %7s %7s %8s %9s %8s %7s" %
+          ("mode/file", "p50 ms", "p90 ms", "p99 ms", "cpu ms", "files/s",
+           "tag MB/s", "RSS KB", "rd+wr"))
+    for key in sorted(results):
+        r = results[key]
+        rw_syscalls = ("-" if r["rw_syscalls"] is None
+                       else str(r["rw_syscalls"]))
+        print("%-22s %7.2f %7.2f %7.2f %7.2f %8.1f %9.1f %8d %7s" %
+              (key, r["p50_ms"], r["p90_ms"], r["p99_ms"], r["cpu_ms"],
+               r["files_per_s"], r["tag_mb_per_s"], r["max_rss_kb"],
+               rw_syscalls))
+
+
+def compare(results, baseline, threshold, timing):
+    """returns the number of regressions"""
+    regressions = 0
+    for key in sorted(results):
+        if key not in baseline:
+            continue
+        new = results[key]
+        old = baseline[key]
+        if (timing and
+                new["p50_ms"] > old["p50_ms"] * (1 + threshold) + SLACK_MS):
+            print("REGRESSION %s: p50 %.2f ms, baseline %.2f ms" %
+                  (key, new["p50_ms"], old["p50_ms"]))
+            regressions += 1
+        if (new["max_rss_kb"] >
+                old["max_rss_kb"] * (1 + threshold) + SLACK_RSS_KB):
+            print("REGRESSION %s: peak RSS %d KB, baseline %d KB" %
+                  (key, new["max_rss_kb"], old["max_rss_kb"]))
+            regressions += 1
+        if (new["rw_syscalls"] is not None and
+                old["rw_syscalls"] is not None and
+                new["rw_syscalls"] >
+                old["rw_syscalls"] * (1 + threshold) + SLACK_RW_SYSCALLS):
+            print("REGRESSION %s: %d read/write system calls, baseline %d" %
+                  (key, new["rw_syscalls"], old["rw_syscalls"]))
+            regressions += 1
+    return regressions
+
+# ======================================================================
+def main(argv):
+    apetag = "./apetag"
+    benchrun = "./benchrun"
+    directory = "_bench"
+    runs = 15
+    baseline = None
+    threshold = 0.25
+    save = False
+    timing = False
+
+    try:
+        opts, args = getopt.getopt(argv, "a:r:c:n:b:t:sT")
+    except getopt.error:
+        print(USAGE)
+        return -1
+    if args:
+        print(USAGE)
+        return -1
+
+    for opt, val in opts:
+        if opt == "-a":
+            apetag = val
+        elif opt == "-r":
+            benchrun = val
+        elif opt == "-c":
+            directory = val
+        elif opt == "-n":
+            runs = int(val)
+        elif opt == "-b":
+            baseline = val
+        elif opt == "-t":
+            threshold = float(val)
+        elif opt == "-s":
+            save = True
+        elif opt == "-T":
+            timing = True
+
+    results = run_benchmarks(os.path.abspath(benchrun),
+                             os.path.abspath(apetag), directory, runs)
+    report(results)
+
+    if baseline is None:
+        return 0
+
+    if save:
+        with open(baseline, "w") as out:
+            json.dump(results, out, indent=2, sort_keys=True)
+            out.write("\n")
+        print("saved baseline " + baseline)
+        return 0
+
+    if not os.path.exists(baseline):
+        print("no baseline " + baseline)
+        return 0
+
+    with open(baseline) as inp:
+        regressions = compare(results, json.load(inp), threshold,
+                              timing)
+    if regressions:
+        print("bench FAILED: %d regressions" % regressions)
+        return 1
+    print("bench OK")
+    return 0
+
+# ======================================================================
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
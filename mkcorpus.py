@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+
+# ======================================================================
+#
+#     Copyright (C) 2004 and onward Robert Muth <robert at muth dot org>
+#
+#     This program is free software: you can redistribute it and/or modify
+#     it under the terms of the GNU General Public License as published by
+#     the Free Software Foundation, version 3 of the License.
+#
+#     This program is distributed in the hope that it will be useful,
+#     but WITHOUT ANY WARRANTY; without even the implied warranty of
+#     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#     GNU General Public License for more details.
+#
+# ======================================================================
+
+"""
+Generates synthetic APE tagged files for benchmarking apetag.
+
+Each file consists of some stand in audio data followed by an APEv2 tag
+with a given number of text items of a given size, optionally a binary
+item, and optionally an ID3v1 tag.
+"""
+
+USAGE = """
+mkcorpus.py - generate a benchmark corpus of APE tagged files
+usage:
+    mkcorpus.py [--audio bytes] directory
+"""
+
+# python imports
+import os
+import struct
+import sys
+
+# ======================================================================
+APE_MAGIC = b"APETAGEX"
+APE_VERSION = 2000
+APE_FLAG_HAVE_HEADER = 1 << 31
+APE_FLAG_IS_HEADER = 1 << 29
+APE_ITEM_BINARY = 1 << 1
+
+BINARY_KEY = "Cover Art (front)"
+
+AUDIO_SIZE = 4 << 20
+
+# name, text items, text value size, binary item size, id3v1
+CASES = [
+    ("small", 8, 32, 0, False),
+    ("small-id3", 8, 32, 0, True),
+    ("items512", 512, 32, 0, False),
+    ("values16k", 32, 16 << 10, 0, False),
+    ("bin1m", 8, 32, 1 << 20, False),
+    ("bin16m-id3", 8, 32, 16 << 20, True),
+]
+
+# ======================================================================
+def pattern(size, seed):
+    """deterministic filler data"""
+    block = bytes((seed + i * 7) & 0xff for i in range(4096))
+    return (block * (size // len(block) + 1))[:size]
+
+
+def text(size, seed):
+    letters = b"abcdefghijklmnopqrstuvwxyz"
+    return bytes(letters[(seed + i) % len(letters)] for i in range(size))
+
+
+def ape_item(key, value, flags=0):
+    return (struct.pack("<II", len(value), flags) + key.encode("ascii") +
+            b"\0" + value)
+
+
+def ape_header_footer(item_bytes, num_items, flags):
+    return (APE_MAGIC +
+            struct.pack("<IIII", APE_VERSION, len(item_bytes) + 32,
+                        num_items, flags) +
+            b"\0" * 8)
+
+
+def ape_tag(num_items, value_size, binary_size):
+    items = [ape_item("Item%04d" % i, text(value_size, i))
+             for i in range(num_items)]
+    if binary_size:
+        items.append(ape_item(BINARY_KEY,
+                              b"cover.jpg\0" + pattern(binary_size, 1),
+                              APE_ITEM_BINARY))
+    item_bytes = b"".join(items)
+    return (ape_header_footer(item_bytes, len(items),
+                              APE_FLAG_HAVE_HEADER | APE_FLAG_IS_HEADER) +
+            item_bytes +
+            ape_header_footer(item_bytes, len(items), APE_FLAG_HAVE_HEADER))
+
+
+def id3v1_tag():
+    return b"TAG" + text(30, 0) + b"\0" * 95
+
+
+def make_file(path, audio_size, num_items, value_size, binary_size, id3v1):
+    with open(path, "wb") as out:
+        out.write(pattern(audio_size, 0))
+        out.write(ape_tag(num_items, value_size, binary_size))
+        if id3v1:
+            out.write(id3v1_tag())
+
+
+def make_corpus(directory, audio_size=AUDIO_SIZE):
+    """returns a list of (name, path, case) for all CASES"""
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    corpus = []
+    for case in CASES:
+        name = case[0]
+        path = os.path.join(directory, name + ".ape")
+        make_file(path, audio_size, *case[1:])
+        corpus.append((name, path, case))
+    return corpus
+
+# ======================================================================
+def main(argv):
+    audio_size = AUDIO_SIZE
+    if len(argv) == 3 and argv[0] == "--audio":
+        audio_size = int(argv[1])
+        argv = argv[2:]
+    if len(argv) != 1:
+        print(USAGE)
+        return -1
+
+    for name, path, _ in make_corpus(argv[0], audio_size):
+        print("%-12s %10d %s" % (name, os.path.getsize(path), path))
+    return 0
+
+# ======================================================================
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -9,6 +9,14 @@ readonly MP3=TestData/empty.mp3
 readonly MP3_APEONLY=TestData/empty_ape.mp3
 readonly MP3_CLONE=TestData/clone.mp3
 readonly MP3_CLONEAPE=TestData/clone_ape.mp3
+readonly MP3_LINK=TestData/link.mp3
+readonly FIFO=TestData/fifo
+readonly MANIFEST=TestData/manifest.txt
+readonly INDEX=TestData/index.idx
+readonly LIBRARY=TestData/library
+readonly STATS=TestData/stats.json
+readonly LARGE=TestData/large.bin
+readonly LARGE_OUT=TestData/large.out
 readonly BIN1=./test.sh
 readonly BIN2=./COPYING
 readonly BIN3=./README.md
@@ -18,6 +26,13 @@ COUNTER=0
 cleanup() {
     rm -f ${MP3_CLONE}
     rm -f ${MP3_CLONEAPE}
+    rm -f ${MP3_LINK}
+    rm -f ${FIFO}
+    rm -f ${MANIFEST}
+    rm -f ${INDEX}
+    rm -rf ${LIBRARY}
+    rm -f ${STATS}
+    rm -f ${LARGE} ${LARGE_OUT}
 }
 trap cleanup EXIT
 
@@ -211,5 +226,121 @@ ${APETAG} -i ${MP3_CLONE} -m read
 newtest  Test10
 ${APETAG} -i ${MP3_CLONEAPE} -m read
 
+newtest  Batch
+${APETAG} -j 1 -i ${MP3_CLONE} -i ${MP3_CLONEAPE} -m update -p "Title=--batch--"
+${APETAG} -j 1 -i ${MP3_CLONE} -i ${MP3_CLONEAPE} -i TestData/missing.mp3 -m read || echo "failed with $?"
+printf '%s\t-p Track=1\t-ro Title\n%s\t-p Track=2\n' ${MP3_CLONE} ${MP3_CLONEAPE} > ${MANIFEST}
+${APETAG} -j 1 -files-from ${MANIFEST} -m update -p "Album=--album--"
+${APETAG} -j 1 -m read -files-from - < ${MANIFEST}
+# lines for the same file are applied to it together
+for i in $(seq 1 16); do printf '%s\t-p Item%02d=%d\n' ${MP3_CLONE} $i $i; done > ${MANIFEST}
+${APETAG} -j 8 -files-from ${MANIFEST} -m update -p "Comment=--merged--"
+${APETAG} -i ${MP3_CLONE} -m read
+
+newtest  Padding
+${APETAG} -i ${MP3_CLONE} -m update -f "Copying"=${BIN2} -p Title="--title2--" -padding 100
+wc -c < ${MP3_CLONE}
+${APETAG} -i ${MP3_CLONE} -m read
+${APETAG} -i ${MP3_CLONE} -m update -p Title="--title3--" -p Year="2003"
+wc -c < ${MP3_CLONE}
+${APETAG} -i ${MP3_CLONE} -m setro
+${APETAG} -i ${MP3_CLONE} -m setrw
+${APETAG} -i ${MP3_CLONE} -m update -p Year=""
+wc -c < ${MP3_CLONE}
+${APETAG} -i ${MP3_CLONE} -m update -p Comment="$(printf '%0150d' 0)"
+wc -c < ${MP3_CLONE}
+${APETAG} -i ${MP3_CLONE} -m update -p Dummy="--dummy--"
+${APETAG} -i ${MP3_CLONE} -m update -p Year="2004" -padding -100 || echo "failed with $?"
+${APETAG} -i ${MP3_CLONE} -m read -f "Copying"=${BIN2}.padding
+diff ${BIN2} ${BIN2}.padding
+rm -f ${BIN2}.padding
+
+newtest  NotRegular
+# only regular files are embedded, the tag is left as it is
+${APETAG} -i ${MP3_CLONE} -m update -p Title="--title--"
+${APETAG} -i ${MP3_CLONE} -m update -f "Cover"=TestData -p Title="--dir--" || echo "failed with $?"
+mkfifo ${FIFO}
+${APETAG} -i ${MP3_CLONE} -m update -f "Cover"=${FIFO} -p Title="--fifo--" || echo "failed with $?"
+rm -f ${FIFO}
+${APETAG} -i ${MP3_CLONE} -m read
+
+newtest  Durable
+${APETAG} -i ${MP3_CLONE} -m update -f "Copying"=${BIN2} -p Title="--title--" -durable
+${APETAG} -i ${MP3_CLONE} -m read
+${APETAG} -i ${MP3_CLONE} -m update -f "Copying"="" -p Artist="--artist--" -durable
+${APETAG} -i ${MP3_CLONE} -m read
+${APETAG} -i ${MP3_CLONE} -m erase -durable
+${APETAG} -i ${MP3_CLONE} -m read
+cmp ${MP3} ${MP3_CLONE} && echo "same as original"
+# the file a symbolic link points to is replaced, not the link
+ln -s $(basename ${MP3_CLONE}) ${MP3_LINK}
+${APETAG} -i ${MP3_LINK} -m update -p Title="--linked--" -durable
+test -L ${MP3_LINK} && echo "still a link"
+${APETAG} -i ${MP3_CLONE} -m read
+${APETAG} -i ${MP3_LINK} -m erase -durable
+rm -f ${MP3_LINK}
+
+newtest  LargeItems
+# values over 64 KiB stay in the file while the tag is rewritten around them
+cat ${BIN2} ${BIN2} ${BIN2} > ${LARGE}
+${APETAG} -i ${MP3_CLONE} -m update -f "Large"=${LARGE} -p Title="--title--"
+${APETAG} -i ${MP3_CLONE} -m update -p Artist="--artist--" -p Title=
+${APETAG} -i ${MP3_CLONE} -m update -p Album="--album--" -durable
+${APETAG} -i ${MP3_CLONE} -m update -p Album="--a--" -padding 100
+${APETAG} -i ${MP3_CLONE} -m update -p Album="--album--"
+${APETAG} -i ${MP3_CLONE} -m read -f "Large"=${LARGE_OUT}
+cmp ${LARGE} ${LARGE_OUT} && echo "large item intact"
+# imported large values are copied from the imported file
+${APETAG} -i ${MP3_CLONEAPE} -m overwrite -file ${MP3_CLONE}
+rm -f ${LARGE_OUT}
+${APETAG} -i ${MP3_CLONEAPE} -m read -f "Large"=${LARGE_OUT}
+cmp ${LARGE} ${LARGE_OUT} && echo "imported large item intact"
+# a large read only item is neither replaced nor removed
+${APETAG} -i ${MP3_CLONE} -m update -ro "Large"
+${APETAG} -i ${MP3_CLONE} -m update -f "Large"=""
+${APETAG} -i ${MP3_CLONE} -m update -p "Large="
+rm -f ${LARGE_OUT}
+${APETAG} -i ${MP3_CLONE} -m read -f "Large"=${LARGE_OUT}
+cmp ${LARGE} ${LARGE_OUT} && echo "read only large item intact"
+${APETAG} -i ${MP3_CLONE} -m update -rw "Large"
+# removing it leaves more slack than is kept as padding
+${APETAG} -i ${MP3_CLONE} -m update -f "Large"=""
+wc -c < ${MP3_CLONE}
+
+newtest  Stats
+# the times and the memory use vary from run to run
+stats() {
+    sed -e 's/"\(wall\|cpu\)_us": [0-9]*, //g' -e '/peak_rss_kb/d' ${STATS}
+}
+${APETAG} -i ${MP3_CLONE} -m update -p Title="--title--" -stats ${STATS}
+stats
+${APETAG} -j 1 -i ${MP3_CLONE} -i TestData/missing.mp3 -m read -stats ${STATS} || echo "failed with $?"
+stats
+# a failing single file is reported too
+rm -f ${STATS}
+${APETAG} -i TestData/missing.mp3 -m read -stats ${STATS} || echo "failed with $?"
+stats
+# embedding an unchanged large file again writes nothing
+${APETAG} -i ${MP3_CLONE} -m update -f "Large"=${LARGE} -padding 100
+${APETAG} -i ${MP3_CLONE} -m update -f "Large"=${LARGE} -stats ${STATS}
+grep -o '"bytes_written": [0-9]*' ${STATS} | sort -u
+
+newtest  Index
+${APETAG} -i ${MP3_CLONE} -m update -p Artist="--artist--" -p Title="--title--"
+${APETAG} -i ${MP3_CLONE} -i ${MP3_CLONEAPE} -index ${INDEX} -m index
+${APETAG} -index ${INDEX} -m query -p artist="--artist--"
+${APETAG} -index ${INDEX} -m query -p Title=
+${APETAG} -i ${MP3_CLONEAPE} -m update -p Artist="--artist--"
+${APETAG} -i ${MP3_CLONE} -i ${MP3_CLONEAPE} -index ${INDEX} -m index
+${APETAG} -index ${INDEX} -m query -p Artist="--artist--" -p Title="--title--"
+${APETAG} -index ${INDEX} -m query -p Artist="--artist--"
+# an index within the indexed directory skips itself and temporary indexes
+mkdir -p ${LIBRARY}
+cp ${MP3_CLONE} ${MP3_CLONEAPE} ${LIBRARY}
+echo "stale" > ${LIBRARY}/library.idx.AbC123
+${APETAG} -i ${LIBRARY} -index ${LIBRARY}/library.idx -m index
+${APETAG} -i ${LIBRARY} -index ${LIBRARY}/library.idx -m index
+${APETAG} -index ${LIBRARY}/library.idx -m query
+rm -rf ${LIBRARY}
 
 echo "done"